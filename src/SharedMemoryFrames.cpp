@@ -0,0 +1,435 @@
+/*
+ * Version     : 1.0
+ * Description : This file contains a shared memory frame ring to pass images between processes using OpenCV
+ *               1. Capture process - writes frames into the ring (stand-in for a camera)
+ *               2. Edit process    - changes brightness and contrast of the frames inside the ring
+ *               3. Draw process    - draws shapes and text on the frames and displays them
+ *
+ * NOTE: The ring is a POSIX shared memory object with fixed size frame slots. Every process wraps a slot
+ *       as Mat header (no copy), so a frame goes from capture to edit to draw without writing any file.
+ *       On older glibc versions link with -lrt for shm_open().
+ *
+ * Steps to use: All the individual functionalities are implemented as preprocessor blocks inside main function.
+ *               Here the 3 blocks work together, so compile this file 3 times with one macro each, ex.
+ *               g++ -std=c++11 SharedMemoryFrames.cpp -DFRAME_RING_CAPTURE -o capture `pkg-config --cflags --libs opencv4`
+ *               and then start capture, edit and draw as 3 separate processes (in any order).
+ *               Edit and draw wait for the ring of a running capture process, a ring left over from a crashed run is ignored.
+ *               When one of the processes crashes or is stopped (ex. Ctrl-C), the other processes stop with an error.
+ */
+
+#include<opencv2/highgui.hpp>
+#include<opencv2/imgproc.hpp>
+#include<iostream>
+#include<string>
+#include<atomic>
+#include<chrono>
+#include<thread>
+#include<new>
+#include<cstdint>
+#include<cerrno>
+#include<fcntl.h>
+#include<signal.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include<unistd.h>
+
+using namespace cv;
+using namespace std;
+
+// #define FRAME_RING_CAPTURE
+// #define FRAME_RING_EDIT
+// #define FRAME_RING_DRAW
+
+/*
+ * Layout of the shared memory object:
+ * [ FrameRingHeader | slot 0 | slot 1 | ... | slot N-1 ]
+ *
+ * Frame number n always lives in slot (n % slotCount). Each stage (capture, edit, draw) only publishes
+ * how many frames it has finished. A stage works on frame n when its previous stage has finished it,
+ * and capture reuses a slot only when draw has finished the frame which was in it before.
+ * Every counter is written by one process only, so atomic load/store (acquire/release) is enough - no locks.
+ * Each stage also stores its process id, so waiting processes can find out when a stage has stopped without closing,
+ * and a stage can be attached by one process of one run only.
+ */
+
+const char *FRAME_RING_NAME = "/opencv_frame_ring";
+const uint64_t FRAME_RING_MAGIC = 0x474E4952454D4146ULL;  // ring is ready when header contains this value
+
+const int FRAME_RING_SLOTS = 4;
+const int FRAME_RING_ROWS = 480;
+const int FRAME_RING_COLS = 640;
+const int FRAME_RING_TYPE = CV_8UC3;
+const int FRAME_RING_NUM_OF_FRAMES = 300;
+
+enum FrameRingStage
+{
+	STAGE_CAPTURE = 0,
+	STAGE_EDIT = 1,
+	STAGE_DRAW = 2,
+	NUM_OF_STAGES = 3
+};
+
+struct FrameRingStageCounter
+{
+	alignas(64) atomic<unsigned long long> done;  // number of frames finished by this stage (own cache line)
+	atomic<bool> closed;                          // stage will not finish any more frames
+	atomic<int> pid;                              // process of this stage, 0 until a process has attached
+};
+
+struct FrameRingHeader
+{
+	atomic<unsigned long long> magic;
+	int32_t slotCount;
+	int32_t rows;
+	int32_t cols;
+	int32_t type;
+	uint64_t slotBytes;   // frame size rounded up to 64 bytes
+	FrameRingStageCounter stage[NUM_OF_STAGES];
+};
+
+// atomics are shared between processes, so they must not use any hidden lock
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "64 bit atomics must be lock free");
+static_assert(ATOMIC_BOOL_LOCK_FREE == 2, "bool atomics must be lock free");
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "int atomics must be lock free");
+
+static void waitShortly()
+{
+	this_thread::sleep_for(chrono::microseconds(100));
+}
+
+/*
+ * creates (or re-creates) the shared memory object and initialises the header.
+ * returns nullptr in case of error
+ */
+FrameRingHeader* createFrameRing(int slotCount, int rows, int cols, int type)
+{
+	uint64_t frameBytes = (uint64_t)rows * cols * CV_ELEM_SIZE(type);
+	uint64_t slotBytes = (frameBytes + 63) & ~(uint64_t)63;
+	uint64_t totalBytes = sizeof(FrameRingHeader) + slotBytes * slotCount;
+
+	shm_unlink(FRAME_RING_NAME);  // remove old ring, if previous run was not closed properly
+
+	int fd = shm_open(FRAME_RING_NAME, O_CREAT | O_EXCL | O_RDWR, 0600);
+	if (fd < 0)
+	{
+		cerr << "shm_open failed for " << FRAME_RING_NAME << endl;
+		return nullptr;
+	}
+	if (ftruncate(fd, totalBytes) != 0)
+	{
+		cerr << "ftruncate failed for " << FRAME_RING_NAME << endl;
+		close(fd);
+		shm_unlink(FRAME_RING_NAME);
+		return nullptr;
+	}
+
+	void *memory = mmap(nullptr, totalBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);  // mapping stays valid after closing the descriptor
+	if (memory == MAP_FAILED)
+	{
+		cerr << "mmap failed for " << FRAME_RING_NAME << endl;
+		shm_unlink(FRAME_RING_NAME);
+		return nullptr;
+	}
+
+	FrameRingHeader *ring = new (memory) FrameRingHeader();
+	ring->slotCount = slotCount;
+	ring->rows = rows;
+	ring->cols = cols;
+	ring->type = type;
+	ring->slotBytes = slotBytes;
+	for (int i = 0; i < NUM_OF_STAGES; i++)
+	{
+		ring->stage[i].done.store(0, memory_order_relaxed);
+		ring->stage[i].closed.store(false, memory_order_relaxed);
+		ring->stage[i].pid.store(0, memory_order_relaxed);
+	}
+	ring->stage[STAGE_CAPTURE].pid.store(getpid(), memory_order_relaxed);
+
+	// publish the header last, other processes wait for the magic value
+	ring->magic.store(FRAME_RING_MAGIC, memory_order_release);
+	return ring;
+}
+
+// true when the process with this id is still running
+static bool isProcessRunning(int pid)
+{
+	return kill(pid, 0) == 0 || errno == EPERM;
+}
+
+/*
+ * true when a process has attached to the stage and stopped (crashed or killed) without closing it.
+ * Such a stage will never finish any more frames.
+ */
+static bool isStageLost(FrameRingHeader *ring, int stage)
+{
+	int pid = ring->stage[stage].pid.load(memory_order_acquire);
+	return pid != 0 && !ring->stage[stage].closed.load(memory_order_acquire) && !isProcessRunning(pid);
+}
+
+/*
+ * opens the ring created by the capture process and attaches to the given stage. waits until the ring exists,
+ * is initialised, belongs to a running capture process and the stage is not used yet in this run.
+ * A ring of a crashed capture process (left over in /dev/shm) and a ring of a run, where the stage has already
+ * been done by another process (ex. waiting for draw to finish), are skipped until capture creates a new ring.
+ * returns nullptr in case of error or when the stage is used by another running process.
+ */
+FrameRingHeader* openFrameRing(int stage)
+{
+	while (true)
+	{
+		int fd = shm_open(FRAME_RING_NAME, O_RDWR, 0);
+		if (fd < 0)
+		{
+			waitShortly();
+			continue;
+		}
+
+		// size is zero until the creator has called ftruncate()
+		struct stat info;
+		if (fstat(fd, &info) != 0)
+		{
+			cerr << "fstat failed for " << FRAME_RING_NAME << endl;
+			close(fd);
+			return nullptr;
+		}
+		if (info.st_size < (off_t)sizeof(FrameRingHeader))
+		{
+			close(fd);
+			waitShortly();
+			continue;
+		}
+
+		size_t mappedBytes = info.st_size;
+		void *memory = mmap(nullptr, mappedBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if (memory == MAP_FAILED)
+		{
+			cerr << "mmap failed for " << FRAME_RING_NAME << endl;
+			close(fd);
+			return nullptr;
+		}
+
+		FrameRingHeader *ring = static_cast<FrameRingHeader*>(memory);
+		bool ready = ring->magic.load(memory_order_acquire) == FRAME_RING_MAGIC;
+
+		// check again after magic: name may have been unlinked by a new capture process (stale ring)
+		bool linked = fstat(fd, &info) == 0 && info.st_nlink > 0;
+		close(fd);
+
+		if (ready && linked && isProcessRunning(ring->stage[STAGE_CAPTURE].pid.load(memory_order_acquire)))
+		{
+			int otherPid = 0;
+			if (ring->stage[stage].pid.compare_exchange_strong(otherPid, getpid(), memory_order_acq_rel))
+			{
+				return ring;
+			}
+			if (isProcessRunning(otherPid))
+			{
+				cerr << "stage " << stage << " of " << FRAME_RING_NAME << " is already used by process " << otherPid << endl;
+				munmap(memory, mappedBytes);
+				return nullptr;
+			}
+		}
+
+		// not ready yet or left over from an old run, open the name again
+		munmap(memory, mappedBytes);
+		waitShortly();
+	}
+}
+
+void releaseFrameRing(FrameRingHeader *ring)
+{
+	munmap(ring, sizeof(FrameRingHeader) + ring->slotBytes * ring->slotCount);
+}
+
+/*
+ * Mat header on the slot of given frame number. No data is copied or allocated,
+ * so the Mat must not be resized or re-created (ex. by assigning a new image to it).
+ */
+Mat frameRingSlot(FrameRingHeader *ring, uint64_t frameNumber)
+{
+	unsigned char *slots = reinterpret_cast<unsigned char*>(ring) + sizeof(FrameRingHeader);
+	unsigned char *slot = slots + (frameNumber % ring->slotCount) * ring->slotBytes;
+	return Mat(ring->rows, ring->cols, ring->type, slot);
+}
+
+/*
+ * waits until the input stage has finished the given frame.
+ * returns false when the input stage is closed or lost (process stopped) and will never deliver this frame.
+ */
+bool waitForFrame(FrameRingHeader *ring, int inputStage, uint64_t frameNumber)
+{
+	FrameRingStageCounter &input = ring->stage[inputStage];
+	while (true)
+	{
+		if (frameNumber < input.done.load(memory_order_acquire))
+		{
+			return true;
+		}
+		// closed is stored after the last frame, so check done once more after reading it
+		if (input.closed.load(memory_order_acquire))
+		{
+			return frameNumber < input.done.load(memory_order_acquire);
+		}
+		if (isStageLost(ring, inputStage))
+		{
+			cerr << "stage " << inputStage << " of " << FRAME_RING_NAME << " stopped without closing" << endl;
+			return false;
+		}
+		waitShortly();
+	}
+}
+
+/*
+ * waits until the slot of the given frame number is not used by any stage anymore.
+ * returns false when draw is closed or lost (process stopped), then the slot will never be free.
+ */
+bool waitForFreeSlot(FrameRingHeader *ring, uint64_t frameNumber)
+{
+	FrameRingStageCounter &draw = ring->stage[STAGE_DRAW];
+	while (frameNumber >= draw.done.load(memory_order_acquire) + ring->slotCount)
+	{
+		if (draw.closed.load(memory_order_acquire))
+		{
+			return frameNumber < draw.done.load(memory_order_acquire) + ring->slotCount;
+		}
+		if (isStageLost(ring, STAGE_DRAW))
+		{
+			cerr << "stage " << STAGE_DRAW << " of " << FRAME_RING_NAME << " stopped without closing" << endl;
+			return false;
+		}
+		waitShortly();
+	}
+	return true;
+}
+
+void publishFrame(FrameRingHeader *ring, int stage, uint64_t frameNumber)
+{
+	ring->stage[stage].done.store(frameNumber + 1, memory_order_release);
+}
+
+void closeStage(FrameRingHeader *ring, int stage)
+{
+	ring->stage[stage].closed.store(true, memory_order_release);
+}
+
+
+int main()
+{
+
+#ifdef FRAME_RING_CAPTURE
+
+	/*
+	 * Stand-in for a camera: the test image is shifted a bit in every frame, so that consecutive frames differ.
+	 * A real camera driver would write into the slot in the same way (frameRingSlot() gives the target memory).
+	 */
+
+	FrameRingHeader *ring = createFrameRing(FRAME_RING_SLOTS, FRAME_RING_ROWS, FRAME_RING_COLS, FRAME_RING_TYPE);
+	if (ring == nullptr)
+	{
+		return 1;
+	}
+
+	Mat loadImg = imread("test.jpg"), cameraImage;
+	resize(loadImg, cameraImage, Size(FRAME_RING_COLS, FRAME_RING_ROWS));
+
+	uint64_t frameNumber = 0;
+	for (; frameNumber < FRAME_RING_NUM_OF_FRAMES; frameNumber++)
+	{
+		if (!waitForFreeSlot(ring, frameNumber))
+		{
+			break;  // draw has stopped, no slot will be free anymore
+		}
+
+		Mat frame = frameRingSlot(ring, frameNumber);
+		int shift = (frameNumber * 8) % FRAME_RING_COLS;
+		cameraImage.colRange(shift, FRAME_RING_COLS).copyTo(frame.colRange(0, FRAME_RING_COLS - shift));
+		if (shift > 0)
+		{
+			cameraImage.colRange(0, shift).copyTo(frame.colRange(FRAME_RING_COLS - shift, FRAME_RING_COLS));
+		}
+
+		publishFrame(ring, STAGE_CAPTURE, frameNumber);
+	}
+	closeStage(ring, STAGE_CAPTURE);
+
+	// keep the ring alive until the draw process is done (or lost), then remove it
+	while (!ring->stage[STAGE_DRAW].closed.load(memory_order_acquire) && !isStageLost(ring, STAGE_DRAW))
+	{
+		waitShortly();
+	}
+	shm_unlink(FRAME_RING_NAME);
+	releaseFrameRing(ring);
+
+	cout << " Captured frames = " << frameNumber << endl;
+
+#endif
+
+#ifdef FRAME_RING_EDIT
+
+	/*
+	 * Same operations as CHANGE_BRIGHTNESS_OF_IMAGE and CHANGE_CONTRAST_OF_IMAGE in ImageEditing.cpp,
+	 * but the result is written back into the same slot (in-place), so the size and type of the frame stay the same.
+	 */
+
+	FrameRingHeader *ring = openFrameRing(STAGE_EDIT);
+	if (ring == nullptr)
+	{
+		return 1;
+	}
+
+	uint64_t frameNumber = 0;
+	while (waitForFrame(ring, STAGE_CAPTURE, frameNumber))
+	{
+		Mat frame = frameRingSlot(ring, frameNumber);
+
+		frame += Scalar(30,30,30);              // increase brightness
+		frame.convertTo(frame, -1, 1.2, 0);     // increase contrast
+
+		publishFrame(ring, STAGE_EDIT, frameNumber);
+		frameNumber++;
+	}
+	closeStage(ring, STAGE_EDIT);
+	releaseFrameRing(ring);
+
+	cout << " Edited frames = " << frameNumber << endl;
+
+#endif
+
+#ifdef FRAME_RING_DRAW
+
+	/*
+	 * Same drawing functions as DRAW_RECTANGLE, DRAW_CIRCLE and TEXT_ON_IMAGE in DrawShapes.cpp,
+	 * drawn directly on the slot and displayed.
+	 */
+
+	FrameRingHeader *ring = openFrameRing(STAGE_DRAW);
+	if (ring == nullptr)
+	{
+		return 1;
+	}
+
+	uint64_t frameNumber = 0;
+	while (waitForFrame(ring, STAGE_EDIT, frameNumber))
+	{
+		Mat frame = frameRingSlot(ring, frameNumber);
+
+		rectangle(frame, Point(100,100), Point(300,300), Scalar(0,0,200), 3);
+		circle(frame, Point(frame.cols / 2, frame.rows / 2), 100, Scalar(255,0,0), 3);
+		putText(frame, "frame " + to_string(frameNumber), Point(10,50), FONT_HERSHEY_SIMPLEX, 1, Scalar(0,0,255), 3);
+
+		imshow("Frame from shared memory", frame);
+		waitKey(1);
+
+		publishFrame(ring, STAGE_DRAW, frameNumber);
+		frameNumber++;
+	}
+	closeStage(ring, STAGE_DRAW);
+	releaseFrameRing(ring);
+
+	cout << " Drawn frames = " << frameNumber << endl;
+
+#endif
+
+	return 0;
+}
@@ -0,0 +1,359 @@
+/*
+ * Version     : 1.0
+ * Description : This file contains the functions to generate synthetic images (test patterns) using OpenCV
+ *               1. Gradient image
+ *               2. Noise image
+ *               3. Checkerboard image
+ *               4. Shape scene image (shapes from DrawShapes.cpp on gradient background)
+ *               5. Bulk generation of frames at many resolutions (load test)
+ *
+ * NOTE: All generators are deterministic - same seed and same image size give exactly the same image,
+ *       also independent of number of threads. So no test images need to be stored on disk.
+ *       The generators write into an already created Mat (of type CV_8UC1 ... CV_8UC4), hence the same Mat
+ *       (or a Mat header on other memory, ex. shared memory slot) can be reused for every frame.
+ *       Gradient, noise and checkerboard do not allocate any memory, shape scene does (text and OpenCV drawing functions).
+ *       Rows are filled in parallel using parallel_for_(). Repeated rows are computed once and copied with memcpy(),
+ *       one colour rows use setTo() and the noise loop is simple enough to be vectorized (SIMD) by the compiler,
+ *       so compile with optimization (ex. -O3).
+ *
+ * Steps to use: All the individual functionalities are implemented as preprocessor blocks inside main function.
+ *               Please activate one block at a time and use as reference recipe for image processing techniques.
+ *				 One can just activate macro by uncommenting the corrsponding #define line and use it.
+ */
+
+#include<opencv2/core.hpp>
+#include<opencv2/highgui.hpp>
+#include<opencv2/imgproc.hpp>
+#include<iostream>
+#include<string>
+#include<vector>
+#include<cstdint>
+#include<cstring>
+
+using namespace cv;
+using namespace std;
+
+// #define GENERATE_GRADIENT_IMAGE
+// #define GENERATE_NOISE_IMAGE
+// #define GENERATE_CHECKERBOARD_IMAGE
+// #define GENERATE_SHAPE_SCENE_IMAGE
+// #define GENERATE_BULK_FRAMES
+
+
+/*
+ * copies the row sourceRow of the image to the rows firstRow ... lastRow-1 (sourceRow itself is skipped).
+ * used by gradient and checkerboard, where many rows are exactly the same.
+ */
+static void copyImageRow(Mat &image, int sourceRow, int firstRow, int lastRow)
+{
+	size_t rowBytes = image.cols * image.elemSize();
+	const uchar *source = image.ptr<uchar>(sourceRow);
+	for (int y = firstRow; y < lastRow; y++)
+	{
+		if (y != sourceRow)
+		{
+			memcpy(image.ptr<uchar>(y), source, rowBytes);
+		}
+	}
+}
+
+// writes colour of one pixel with given number of channels (max. 4)
+static inline void setPixel(uchar *pixel, const Scalar &color, int channels)
+{
+	for (int c = 0; c < channels; c++)
+	{
+		pixel[c] = saturate_cast<uchar>(color[c]);
+	}
+}
+
+/*
+ * generateGradient(image, seed)
+ * colour changes linearly from one colour to other colour. Seed selects both colours and direction
+ * (horizontal or vertical).
+ */
+void generateGradient(Mat &image, uint64_t seed)
+{
+	CV_Assert(image.depth() == CV_8U && image.channels() <= 4);
+	if (image.empty())
+	{
+		return;  // nothing to fill (ex. 0 rows, data is nullptr)
+	}
+
+	RNG rng(seed);
+	int channels = image.channels();
+	Scalar startColor(rng.uniform(0,256), rng.uniform(0,256), rng.uniform(0,256), 255);
+	Scalar endColor(rng.uniform(0,256), rng.uniform(0,256), rng.uniform(0,256), 255);
+	bool horizontal = rng.uniform(0,2) == 0;
+
+	// colour of step i out of numOfSteps (pixel columns or pixel rows)
+	int numOfSteps = horizontal ? image.cols : image.rows;
+	auto stepColor = [&](int i) -> Scalar
+	{
+		double weight = numOfSteps > 1 ? (double)i / (numOfSteps - 1) : 0.0;
+		return startColor + (endColor - startColor) * weight;
+	};
+
+	if (horizontal)
+	{
+		// every row is the same: compute row 0 and copy it to all other rows
+		uchar *firstRow = image.ptr<uchar>(0);
+		for (int x = 0; x < image.cols; x++)
+		{
+			setPixel(firstRow + x * channels, stepColor(x), channels);
+		}
+
+		parallel_for_(Range(0, image.rows), [&](const Range &range)
+		{
+			copyImageRow(image, 0, range.start, range.end);
+		});
+	}
+	else
+	{
+		// every row has one colour
+		parallel_for_(Range(0, image.rows), [&](const Range &range)
+		{
+			for (int y = range.start; y < range.end; y++)
+			{
+				image.row(y).setTo(stepColor(y));
+			}
+		});
+	}
+}
+
+// integer hash (good bit mixing, only shifts, xor and multiply - vectorizes well)
+static inline uint32_t hashNoise(uint32_t value)
+{
+	value ^= value >> 16;
+	value *= 0x7feb352dU;
+	value ^= value >> 15;
+	value *= 0x846ca68bU;
+	value ^= value >> 16;
+	return value;
+}
+
+/*
+ * generateNoise(image, seed)
+ * uniform random noise between 0 and 255 in all channels. Every value only depends on seed and its position,
+ * so rows can be filled in any order by any thread.
+ */
+void generateNoise(Mat &image, uint64_t seed)
+{
+	CV_Assert(image.depth() == CV_8U);
+	if (image.empty())
+	{
+		return;  // nothing to fill (ex. 0 rows, data is nullptr)
+	}
+
+	uint32_t seedHash = hashNoise((uint32_t)seed ^ hashNoise((uint32_t)(seed >> 32)));
+	int rowValues = image.cols * image.channels();
+
+	parallel_for_(Range(0, image.rows), [&](const Range &range)
+	{
+		for (int y = range.start; y < range.end; y++)
+		{
+			uchar *row = image.ptr<uchar>(y);
+			uint32_t rowStart = seedHash + (uint32_t)y * (uint32_t)rowValues;
+			for (int i = 0; i < rowValues; i++)
+			{
+				row[i] = (uchar)hashNoise(rowStart + (uint32_t)i);
+			}
+		}
+	});
+}
+
+/*
+ * generateCheckerboard(image, squareSize, seed)
+ * squares of squareSize pixels in two colours. Seed selects both colours and shift of the pattern,
+ * so consecutive seeds give a moving checkerboard.
+ */
+void generateCheckerboard(Mat &image, int squareSize, uint64_t seed)
+{
+	CV_Assert(image.depth() == CV_8U && image.channels() <= 4 && squareSize > 0);
+	if (image.empty())
+	{
+		return;  // nothing to fill (ex. 0 rows, data is nullptr)
+	}
+
+	RNG rng(seed);
+	int channels = image.channels();
+	Scalar colors[2] = {
+		Scalar(rng.uniform(0,128), rng.uniform(0,128), rng.uniform(0,128), 255),     // dark colour
+		Scalar(rng.uniform(128,256), rng.uniform(128,256), rng.uniform(128,256), 255) // bright colour
+	};
+	int shiftX = rng.uniform(0, 2 * squareSize);
+	int shiftY = rng.uniform(0, 2 * squareSize);
+
+	// only 2 different rows exist: starting with dark square or starting with bright square.
+	// compute row 0 and the first row of the other kind, all other rows are copies of these two
+	int firstRowKind = (shiftY / squareSize) % 2;
+	int otherRow = squareSize - shiftY % squareSize;
+	int templateRows[2];
+	templateRows[firstRowKind] = 0;
+	templateRows[1 - firstRowKind] = otherRow;
+
+	for (int t = 0; t < 2; t++)
+	{
+		if (templateRows[t] >= image.rows)
+		{
+			continue;  // image is too small to contain this kind of row
+		}
+		uchar *row = image.ptr<uchar>(templateRows[t]);
+		for (int x = 0; x < image.cols; x++)
+		{
+			setPixel(row + x * channels, colors[(((x + shiftX) / squareSize) + t) % 2], channels);
+		}
+	}
+
+	parallel_for_(Range(0, image.rows), [&](const Range &range)
+	{
+		for (int y = range.start; y < range.end; y++)
+		{
+			copyImageRow(image, templateRows[((y + shiftY) / squareSize) % 2], y, y + 1);
+		}
+	});
+}
+
+/*
+ * generateShapeScene(image, numOfShapes, seed)
+ * gradient background with lines, circles, ellipses, rectangles and text (same functions as DrawShapes.cpp).
+ * Position, size and colour of every shape is selected by seed.
+ */
+void generateShapeScene(Mat &image, int numOfShapes, uint64_t seed)
+{
+	CV_Assert(image.depth() == CV_8U && image.channels() <= 4);
+	if (image.empty())
+	{
+		return;  // nothing to fill (ex. 0 rows, data is nullptr)
+	}
+
+	generateGradient(image, seed);
+
+	RNG rng(seed ^ 0x9E3779B97F4A7C15ULL);  // different numbers than used for background
+	int maxSize = max(4, min(image.rows, image.cols) / 4);
+
+	for (int i = 0; i < numOfShapes; i++)
+	{
+		Point centrePoint(rng.uniform(0, image.cols), rng.uniform(0, image.rows));
+		Scalar color(rng.uniform(0,256), rng.uniform(0,256), rng.uniform(0,256), 255);
+		int thickness = rng.uniform(0,2) == 0 ? FILLED : rng.uniform(1,6);
+		int size = rng.uniform(2, maxSize);
+
+		switch (rng.uniform(0,5))
+		{
+		case 0:
+			line(image, centrePoint, Point(rng.uniform(0, image.cols), rng.uniform(0, image.rows)), color, max(thickness,1));
+			break;
+		case 1:
+			circle(image, centrePoint, size, color, thickness);
+			break;
+		case 2:
+			ellipse(image, centrePoint, Size(size, size / 2 + 1), rng.uniform(0,180), 0, 360, color, thickness);
+			break;
+		case 3:
+			rectangle(image, centrePoint, centrePoint + Point(size, size / 2 + 1), color, thickness);
+			break;
+		default:
+			putText(image, "opencv " + to_string(i), centrePoint, FONT_HERSHEY_SIMPLEX, size / 40.0 + 0.5, color, max(thickness,1));
+			break;
+		}
+	}
+}
+
+
+int main()
+{
+
+#ifdef GENERATE_GRADIENT_IMAGE
+
+	Mat grayImage(480,640, CV_8UC1), colorImage(480,640, CV_8UC3);
+
+	generateGradient(grayImage, 1);
+	generateGradient(colorImage, 2);
+
+	imshow("Gradient grayscale image", grayImage);
+	imshow("Gradient color image", colorImage);
+
+	waitKey(0);
+
+#endif
+
+#ifdef GENERATE_NOISE_IMAGE
+
+	Mat grayImage(480,640, CV_8UC1), colorImage(480,640, CV_8UC3);
+
+	generateNoise(grayImage, 1);
+	generateNoise(colorImage, 1);
+
+	imshow("Noise grayscale image", grayImage);
+	imshow("Noise color image", colorImage);
+
+	waitKey(0);
+
+#endif
+
+#ifdef GENERATE_CHECKERBOARD_IMAGE
+
+	Mat grayImage(480,640, CV_8UC1), colorImage(480,640, CV_8UC3);
+
+	int squareSize = 40;  // in pixels
+	generateCheckerboard(grayImage, squareSize, 1);
+	generateCheckerboard(colorImage, squareSize, 2);
+
+	imshow("Checkerboard grayscale image", grayImage);
+	imshow("Checkerboard color image", colorImage);
+
+	waitKey(0);
+
+#endif
+
+#ifdef GENERATE_SHAPE_SCENE_IMAGE
+
+	Mat colorImage(480,640, CV_8UC3);
+
+	int numOfShapes = 20;
+	generateShapeScene(colorImage, numOfShapes, 1);
+
+	imshow("Shape scene image", colorImage);
+
+	waitKey(0);
+
+#endif
+
+#ifdef GENERATE_BULK_FRAMES
+
+	/*
+	 * Generates frames of all patterns at different resolutions and passes each frame directly to a processing step
+	 * (here brightness change from ImageEditing.cpp), without storing it. Frame number is used as seed,
+	 * so every frame is different but a run can always be repeated.
+	 * Image is created only once per resolution and then overwritten for every frame.
+	 */
+
+	vector<Size> resolutions = { Size(320,240), Size(640,480), Size(1280,720), Size(1920,1080) };
+	int numOfFrames = 1000;
+
+	for (const Size &resolution : resolutions)
+	{
+		Mat frame(resolution, CV_8UC3);
+
+		int64 startTicks = getTickCount();
+		for (int frameNumber = 0; frameNumber < numOfFrames; frameNumber++)
+		{
+			switch (frameNumber % 4)
+			{
+			case 0: generateGradient(frame, frameNumber); break;
+			case 1: generateNoise(frame, frameNumber); break;
+			case 2: generateCheckerboard(frame, 32, frameNumber); break;
+			default: generateShapeScene(frame, 10, frameNumber); break;
+			}
+
+			frame += Scalar(50,50,50);  // processing step, ex. increase brightness
+		}
+		double seconds = (getTickCount() - startTicks) / getTickFrequency();
+
+		cout << " Resolution = " << resolution << "  frames per second = " << numOfFrames / seconds << endl;
+	}
+
+#endif
+
+	return 0;
+}